@@ -1,13 +1,93 @@
+#include <fcntl.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "communication.h"
 
+/* Map soswm's state page read-only, returning NULL if it is unavailable
+ *
+ * Long-running readers should map the page once and call read_state() as
+ * often as they like; the mapping goes stale if soswm restarts.
+ */
+const State *open_state() {
+  int fd;
+  if ((fd = shm_open(STATE_SHM_NAME, O_RDONLY, 0)) == -1) {
+    return NULL;
+  }
+  State *page = mmap(NULL, sizeof(State), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  return page == MAP_FAILED ? NULL : page;
+}
+
+/* Copy a consistent snapshot out of the state page, retrying while soswm is
+ * writing to it, returning -1 if no consistent copy could be taken (e.g. soswm
+ * died mid-write)
+ */
+int read_state(const State *page, State *snapshot) {
+  // give soswm up to 100ms to finish a write, even if it is preempted
+  const unsigned int max_retries = 1000;
+  const struct timespec backoff = {.tv_sec = 0, .tv_nsec = 100000};
+  for (unsigned int retry = 0; retry < max_retries; retry++) {
+    unsigned int seq = atomic_load_explicit(&page->seq, memory_order_acquire);
+    if (seq & 1) {
+      nanosleep(&backoff, NULL);
+      continue;
+    }
+    memcpy(snapshot, (const void *)page, sizeof(State));
+    atomic_thread_fence(memory_order_acquire);
+    if (seq == atomic_load_explicit(&page->seq, memory_order_relaxed)) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* Print soswm's state without contacting the server */
+void print_state() {
+  const State *page;
+  if (!(page = open_state())) {
+    fprintf(stderr, "sosc: Could not open state page\n");
+    exit(1);
+  }
+  State state;
+  int read = read_state(page, &state);
+  munmap((void *)page, sizeof(State));
+  if (read == -1) {
+    fprintf(stderr, "sosc: State page unavailable\n");
+    exit(1);
+  }
+  if (state.version != STATE_VERSION) {
+    fprintf(stderr, "sosc: Unsupported state version %u\n", state.version);
+    exit(1);
+  }
+
+  printf("focused 0x%lx\n", state.focused);
+  printf("gap %u\n", state.gap);
+  for (unsigned int s = 0; s < state.num_stacks && s < STATE_MAX_STACKS; s++) {
+    printf("stack %u %s %u 0x%lx\n", state.stacks[s].id,
+           state.stacks[s].name[0] ? state.stacks[s].name : "-",
+           state.stacks[s].num_windows, state.stacks[s].tos);
+  }
+  for (unsigned int s = 0; s < state.num_splits && s < STATE_MAX_SPLITS; s++) {
+    printf("split %ux%u+%d+%d\n", state.splits[s].width,
+           state.splits[s].height, state.splits[s].x, state.splits[s].y);
+  }
+}
+
 int main(int argc, char *argv[]) {
+  // the state page is read directly, without going through soswm
+  if (argc == 2 && !strcmp("--state", argv[1])) {
+    print_state();
+    return 0;
+  }
+
   // create socket
   int data_socket;
   if ((data_socket = socket(AF_UNIX, SOCK_SEQPACKET, 0)) == -1) {
@@ -4,4 +4,36 @@
 #define REQ_BUFFER_SIZE 64
 #define REP_BUFFER_SIZE 2048
 
+/* Shared-memory state page
+ *
+ * soswm publishes a snapshot of its state at the end of each relayout so that
+ * readers can poll it without going through the server. The page is guarded by
+ * a seqlock: seq is odd while a write is in progress, and a reader's copy is
+ * only consistent if seq was even and unchanged across the copy.
+ */
+#define STATE_SHM_NAME "/soswm.state"
+#define STATE_VERSION 1
+#define STATE_MAX_STACKS 32
+#define STATE_MAX_SPLITS 16
+#define STATE_NAME_SIZE 32
+
+typedef struct {
+  _Atomic unsigned int seq;
+  unsigned int version;
+  unsigned long focused; // 0 when nothing is focused
+  unsigned int gap;
+  unsigned int num_stacks; // only the first STATE_MAX_STACKS are recorded
+  struct {
+    unsigned int id;
+    unsigned int num_windows;
+    unsigned long tos; // 0 when the stack is empty
+    char name[STATE_NAME_SIZE];
+  } stacks[STATE_MAX_STACKS]; // ordered stacks, stored TOS...TOS+n
+  unsigned int num_splits; // only the first STATE_MAX_SPLITS are recorded
+  struct {
+    unsigned int width, height;
+    int x, y;
+  } splits[STATE_MAX_SPLITS]; // ordered splits, stored TOS...TOS+n
+} State;
+
 #endif /* !COMMUNICATION_H */
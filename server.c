@@ -1,9 +1,13 @@
+#include <ctype.h>
 #include <limits.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "server.h"
@@ -18,14 +22,23 @@ char usage[] = "usage: sosc [--help] <action> <actor> [argument]\n"
                "sosc swap <window | stack> <0...inf>\n"
                "sosc roll <window | stack> <top | bottom>\n"
                "sosc move window <0...inf>\n"
-               "sosc set gap <0...inf>\n"
-               "sosc split screen <WxH+X+Y> ...\n"
+               "sosc name stack <name>\n"
+               "sosc focus stack <name | id>\n"
+               "sosc focus window <xid>\n"
+               "sosc query <stacks | windows>\n"
+               "sosc set <gap | kill-timeout> <0...inf>\n"
+               "sosc split screen <auto | WxH+X+Y ...>\n"
+               "sosc wait <map | relayout | idle> [class=<class>] "
+               "[timeout=<ms>]\n"
                "sosc logout wm\n"
                "sosc --help\n";
 
 int connection_socket;
 
 void server_init() {
+  // a client that goes away mid-reply must not take soswm down with it
+  signal(SIGPIPE, SIG_IGN);
+
   // create socket
   if ((connection_socket = socket(AF_UNIX, SOCK_SEQPACKET, 0)) == -1) {
     fprintf(stderr, "soswm: Could not initialize socket\n");
@@ -63,7 +76,8 @@ void server_quit() { close(connection_socket); }
  *
  * Each action (stored as a NULL-terminated list) has a NULL-terminated list of
  * possible actors, as well as an argument parser, which is NULL when there is
- * no argument.
+ * no argument. An actor taking a different argument has its own parser, which
+ * overrides the action's.
  */
 typedef struct Actor Actor;
 typedef struct {
@@ -72,6 +86,7 @@ typedef struct {
   struct Actor {
     char *actor;
     void (*handler)();
+    void (*arg_parser)();
   } * actor_options;
   void (*arg_parser)();
 } Command;
@@ -85,6 +100,165 @@ char reply[REP_BUFFER_SIZE];
 #define sock_writef(socket, dest, ...)                                         \
   write(socket, dest, snprintf(dest, sizeof(dest), __VA_ARGS__) + 1)
 
+/* Finish a connection once everything has been written */
+void close_connection(int socket) {
+  shutdown(socket, SHUT_WR);
+  sock_read(socket, request);
+  close(socket);
+}
+
+long long now_ms() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const long long MS_PER_S = 1000, NS_PER_MS = 1000000;
+  return now.tv_sec * MS_PER_S + now.tv_nsec / NS_PER_MS;
+}
+
+/* Clients parked by `sosc wait` until their event occurs or they time out */
+typedef struct {
+  int socket;
+  WaitEvent event;
+  char class[REQ_BUFFER_SIZE]; // empty to match any window
+  long long deadline;
+} Waiter;
+Waiter *waiters = NULL;
+unsigned int num_waiters = 0;
+
+char *wait_event_names[] = {
+    [WAIT_MAP] = "map",
+    [WAIT_RELAYOUT] = "relayout",
+    [WAIT_IDLE] = "idle",
+};
+
+/* Take ownership of the current connection until the event occurs */
+void add_waiter(Waiter waiter) {
+  waiter.socket = data_socket;
+  waiters = realloc(waiters, (num_waiters + 1) * sizeof(Waiter));
+  waiters[num_waiters++] = waiter;
+  data_socket = -1;
+}
+
+/* Reply to and release the nth waiter */
+void remove_waiter(unsigned int n, const char *message) {
+  // never wait on the client here, as it may be suspended
+  if (message[0] != '\0') {
+    write(waiters[n].socket, message, strlen(message) + 1);
+  }
+  close(waiters[n].socket);
+  num_waiters--;
+  memmove(waiters + n, waiters + n + 1, (num_waiters - n) * sizeof(Waiter));
+}
+
+unsigned int server_waiting(WaitEvent event) {
+  unsigned int count = 0;
+  for (unsigned int w = 0; w < num_waiters; w++) {
+    count += waiters[w].event == event;
+  }
+  return count;
+}
+
+void server_notify(WaitEvent event) {
+  for (unsigned int w = 0; w < num_waiters;) {
+    if (waiters[w].event == event) {
+      remove_waiter(w, "");
+    } else {
+      w++;
+    }
+  }
+}
+
+int class_matches(const char *class, const char *res_name,
+                  const char *res_class) {
+  return class[0] == '\0' || (res_name && !strcmp(class, res_name)) ||
+         (res_class && !strcmp(class, res_class));
+}
+
+unsigned int server_notify_map(unsigned long win, const char *res_name,
+                               const char *res_class) {
+  unsigned int released = 0;
+  for (unsigned int w = 0; w < num_waiters;) {
+    if (waiters[w].event == WAIT_MAP &&
+        class_matches(waiters[w].class, res_name, res_class)) {
+      snprintf(reply, sizeof(reply), "0x%lx\n", win);
+      remove_waiter(w, reply);
+      released++;
+    } else {
+      w++;
+    }
+  }
+  return released;
+}
+
+int server_fds(fd_set *set) {
+  int max_fd = -1;
+  for (unsigned int w = 0; w < num_waiters; w++) {
+    FD_SET(waiters[w].socket, set);
+    if (waiters[w].socket > max_fd) {
+      max_fd = waiters[w].socket;
+    }
+  }
+  return max_fd;
+}
+
+void server_reap(fd_set *set) {
+  // waiting clients send nothing more, so a readable socket has hung up
+  for (unsigned int w = 0; w < num_waiters;) {
+    if (FD_ISSET(waiters[w].socket, set)) {
+      remove_waiter(w, "");
+    } else {
+      w++;
+    }
+  }
+}
+
+int server_timeout() {
+  if (!num_waiters) {
+    return -1;
+  }
+  long long next = waiters[0].deadline;
+  for (unsigned int w = 1; w < num_waiters; w++) {
+    if (waiters[w].deadline < next) {
+      next = waiters[w].deadline;
+    }
+  }
+  long long remaining = next - now_ms();
+  return remaining <= 0 ? 0 : remaining > INT_MAX ? INT_MAX : remaining;
+}
+
+void server_expire() {
+  long long now = now_ms();
+  for (unsigned int w = 0; w < num_waiters;) {
+    if (waiters[w].deadline <= now) {
+      snprintf(reply, sizeof(reply), "Timed out waiting for `%s`\n",
+               wait_event_names[waiters[w].event]);
+      remove_waiter(w, reply);
+    } else {
+      w++;
+    }
+  }
+}
+
+void wait_map(Waiter waiter) {
+  // the window may have mapped before the client connected
+  unsigned long win;
+  if (waiter.class[0] != '\0' && claim_mapped_window(waiter.class, &win)) {
+    sock_writef(data_socket, reply, "0x%lx\n", win);
+    return;
+  }
+  waiter.event = WAIT_MAP;
+  add_waiter(waiter);
+}
+
+void wait_relayout(Waiter waiter) {
+  waiter.event = WAIT_RELAYOUT;
+  add_waiter(waiter);
+}
+
+void wait_idle(Waiter waiter) {
+  waiter.event = WAIT_IDLE;
+  add_waiter(waiter);
+}
+
 /* Argument parsers */
 void uint_parser(void (*handler)()) {
   sock_read(data_socket, request);
@@ -98,6 +272,68 @@ void uint_parser(void (*handler)()) {
   handler(res);
 }
 
+void name_parser(void (*handler)()) {
+  sock_read(data_socket, request);
+  if (request[0] == '\0') {
+    sock_writef(data_socket, reply, "Missing argument\n");
+    return;
+  }
+  // names must not be mistaken for ids or for the unnamed `-`, nor break up
+  // the lines of `sosc query stacks`
+  char *end;
+  strtoul(request, &end, 0);
+  int is_id = *request != '-' && end != request && !*end;
+  int has_space = 0;
+  for (char *c = request; *c; c++) {
+    has_space |= isspace((unsigned char)*c) != 0;
+  }
+  if (is_id || has_space || !strcmp("-", request)) {
+    sock_writef(data_socket, reply,
+                "Invalid argument: `%s`\nExpected name that isn't an id or `-` "
+                "and has no whitespace\n",
+                request);
+    return;
+  }
+  handler(request);
+}
+
+/* Send whatever a handler wrote to the reply, if anything */
+void send_reply() {
+  if (reply[0] != '\0') {
+    write(data_socket, reply, strlen(reply) + 1);
+  }
+}
+
+void reply_parser(void (*handler)()) {
+  handler(reply, (unsigned int)sizeof(reply));
+  send_reply();
+}
+
+void stack_ref_parser(void (*handler)()) {
+  sock_read(data_socket, request);
+  if (request[0] == '\0') {
+    sock_writef(data_socket, reply, "Missing argument\n");
+    return;
+  }
+  reply[0] = '\0';
+  handler(request, reply, (unsigned int)sizeof(reply));
+  send_reply();
+}
+
+void xid_parser(void (*handler)()) {
+  sock_read(data_socket, request);
+  char *end;
+  unsigned long xid = strtoul(request, &end, 0);
+  if (*request == '-' || end == request || *end) {
+    sock_writef(data_socket, reply,
+                "Invalid argument: `%s`\nExpected window id\n", request);
+    return;
+  }
+  reply[0] = '\0';
+  handler(xid, reply, (unsigned int)sizeof(reply));
+  send_reply();
+}
+
 void roll_direction_parser(void (*handler)()) {
   sock_read(data_socket, request);
   if (!strcmp("top", request)) {
@@ -121,6 +357,18 @@ void splits_parser(void (*handler)()) {
     if (request[0] == '\0') {
       break;
     }
+    // `auto` on its own passes no splits, following the monitors instead
+    if (!splits.splits && !strcmp("auto", request)) {
+      sock_read(data_socket, request);
+      if (request[0] == '\0') {
+        handler(splits);
+        return;
+      }
+      sock_writef(data_socket, reply,
+                  "Invalid argument: `%s`\n`auto` takes no splits\n",
+                  request);
+      return;
+    }
     Split split;
     const unsigned int expected = 4;
     if (sscanf(request, "%ux%u+%d+%d", &split.width, &split.height, &split.x,
@@ -139,12 +387,49 @@ void splits_parser(void (*handler)()) {
   }
   if (!splits.splits) {
     sock_writef(data_socket, reply,
-                "One or more splits must be specified in form `WxH+x+y`\n");
+                "One or more splits must be specified in form `WxH+x+y`, "
+                "or `auto`\n");
     return;
   }
   handler(splits);
 }
 
+void wait_parser(void (*handler)()) {
+  const long long default_timeout = 10000;
+  Waiter waiter = {
+      .class = "",
+      .deadline = now_ms() + default_timeout,
+  };
+  for (;;) {
+    sock_read(data_socket, request);
+    if (request[0] == '\0') {
+      break;
+    }
+    const char class_opt[] = "class=", timeout_opt[] = "timeout=";
+    if (!strncmp(class_opt, request, sizeof(class_opt) - 1)) {
+      strcpy(waiter.class, request + sizeof(class_opt) - 1);
+    } else if (!strncmp(timeout_opt, request, sizeof(timeout_opt) - 1)) {
+      char *timeout = request + sizeof(timeout_opt) - 1, *end;
+      unsigned long ms = strtoul(timeout, &end, 0);
+      if (*timeout == '-' || end == timeout || *end || ms > MAX_TIMEOUT) {
+        sock_writef(data_socket, reply,
+                    "Invalid argument: `%s`\nExpected timeout from 0 to %d "
+                    "ms\n",
+                    request, MAX_TIMEOUT);
+        return;
+      }
+      waiter.deadline = now_ms() + ms;
+    } else {
+      sock_writef(data_socket, reply,
+                  "Invalid argument: `%s`\nExpected `class=<class>` or "
+                  "`timeout=<ms>`\n",
+                  request);
+      return;
+    }
+  }
+  handler(waiter);
+}
+
 Command commands[] = {
     {.usage = "sosc push stack",
      .action = "push",
@@ -179,19 +464,59 @@ Command commands[] = {
          (Actor[]){{.actor = "window", .handler = move_window}, {NULL}},
      .arg_parser = uint_parser},
 
-    /* sosc set gap <0...inf> */
-    {.usage = "sosc set gap <0...inf>",
+    /* sosc name stack <name> */
+    {.usage = "sosc name stack <name>",
+     .action = "name",
+     .actor_options =
+         (Actor[]){{.actor = "stack", .handler = name_stack}, {NULL}},
+     .arg_parser = name_parser},
+
+    /* sosc focus stack <name | id>, sosc focus window <xid> */
+    {.usage = "sosc focus stack <name | id>\nsosc focus window <xid>",
+     .action = "focus",
+     .actor_options = (Actor[]){{.actor = "stack",
+                                 .handler = focus_stack,
+                                 .arg_parser = stack_ref_parser},
+                                {.actor = "window",
+                                 .handler = focus_window,
+                                 .arg_parser = xid_parser},
+                                {NULL}},
+     .arg_parser = NULL},
+
+    /* sosc query <stacks | windows> */
+    {.usage = "sosc query <stacks | windows>",
+     .action = "query",
+     .actor_options = (Actor[]){{.actor = "stacks", .handler = query_stacks},
+                                {.actor = "windows", .handler = query_windows},
+                                {NULL}},
+     .arg_parser = reply_parser},
+
+    /* sosc set <gap | kill-timeout> <0...inf> */
+    {.usage = "sosc set <gap | kill-timeout> <0...inf>",
      .action = "set",
-     .actor_options = (Actor[]){{.actor = "gap", .handler = set_gap}, {NULL}},
+     .actor_options =
+         (Actor[]){{.actor = "gap", .handler = set_gap},
+                   {.actor = "kill-timeout", .handler = set_kill_timeout},
+                   {NULL}},
      .arg_parser = uint_parser},
 
-    /* sosc split screen <"WxH+X+Y ..."> */
-    {.usage = "sosc split screen <WxH+X+Y> ...",
+    /* sosc split screen <auto | "WxH+X+Y ..."> */
+    {.usage = "sosc split screen <auto | WxH+X+Y ...>",
      .action = "split",
      .actor_options =
          (Actor[]){{.actor = "screen", .handler = split_screen}, {NULL}},
      .arg_parser = splits_parser},
 
+    /* sosc wait <map | relayout | idle> [class=<class>] [timeout=<ms>] */
+    {.usage = "sosc wait <map | relayout | idle> [class=<class>] "
+              "[timeout=<ms>]",
+     .action = "wait",
+     .actor_options = (Actor[]){{.actor = "map", .handler = wait_map},
+                                {.actor = "relayout", .handler = wait_relayout},
+                                {.actor = "idle", .handler = wait_idle},
+                                {NULL}},
+     .arg_parser = wait_parser},
+
     /* sosc logout wm */
     {.usage = "sosc logout wm",
      .action = "logout",
@@ -237,7 +562,9 @@ void server_handler() {
 
         // if actor matches, check arg
         if (!strcmp(actor->actor, request)) {
-          if (cmd->arg_parser) {
+          if (actor->arg_parser) {
+            actor->arg_parser(actor->handler);
+          } else if (cmd->arg_parser) {
             cmd->arg_parser(actor->handler);
           } else {
             actor->handler();
@@ -249,8 +576,9 @@ void server_handler() {
   }
 
 clean_up:
-  // make sure everything is written before shutting down
-  shutdown(data_socket, SHUT_WR);
-  sock_read(data_socket, request);
-  close(data_socket);
+  // make sure everything is written before shutting down, unless the
+  // connection has been parked by `sosc wait`
+  if (data_socket != -1) {
+    close_connection(data_socket);
+  }
 }
@@ -1,6 +1,8 @@
 #ifndef SERVER_H
 #define SERVER_H
 
+#include <sys/select.h>
+
 /* The fd that new connections will appear on */
 extern int connection_socket;
 
@@ -13,4 +15,41 @@ void server_quit();
 /* Handle incoming connection */
 void server_handler();
 
+/* Milliseconds on a monotonic clock */
+long long now_ms();
+
+/* Longest timeout, in milliseconds, that soswm will wait on (one day) */
+#define MAX_TIMEOUT 86400000
+
+/* sosc wait <map | relayout | idle> [class=<class>] [timeout=<ms>] */
+typedef enum { WAIT_MAP, WAIT_RELAYOUT, WAIT_IDLE } WaitEvent;
+
+/* Return the number of clients waiting on an event */
+unsigned int server_waiting(WaitEvent);
+
+/* Release the clients waiting on a relayout or on soswm being idle */
+void server_notify(WaitEvent);
+
+/* Return if a `sosc wait map` class matches a WM_CLASS instance or class */
+int class_matches(const char *class, const char *res_name,
+                  const char *res_class);
+
+/* Release the clients waiting on a window with the given WM_CLASS to map,
+ * returning how many were released
+ */
+unsigned int server_notify_map(unsigned long win, const char *res_name,
+                               const char *res_class);
+
+/* Add the sockets of waiting clients to a set, returning the largest, or -1 */
+int server_fds(fd_set *);
+
+/* Release the waiting clients whose sockets in the set have hung up */
+void server_reap(fd_set *);
+
+/* Return the milliseconds until the next waiting client times out, or -1 */
+int server_timeout();
+
+/* Release the waiting clients that have timed out */
+void server_expire();
+
 #endif /* !SERVER_H */
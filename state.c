@@ -0,0 +1,56 @@
+#include "state.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+State *state = NULL; // NULL when the page couldn't be created
+
+void state_init() {
+  // always start from a fresh page, in case a previous soswm died mid-write
+  shm_unlink(STATE_SHM_NAME);
+  int fd;
+  if ((fd = shm_open(STATE_SHM_NAME, O_CREAT | O_RDWR, 0644)) == -1) {
+    fprintf(stderr, "soswm: Could not create state page\n");
+    return;
+  }
+  // the page is only for readers' convenience, so carry on without it
+  State *page;
+  if (ftruncate(fd, sizeof(State)) == -1 ||
+      (page = mmap(NULL, sizeof(State), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                   0)) == MAP_FAILED) {
+    fprintf(stderr, "soswm: Could not map state page\n");
+    close(fd);
+    shm_unlink(STATE_SHM_NAME);
+    return;
+  }
+  close(fd);
+  state = page;
+  state->version = STATE_VERSION;
+}
+
+void state_quit() {
+  if (state) {
+    munmap(state, sizeof(State));
+    shm_unlink(STATE_SHM_NAME);
+    state = NULL;
+  }
+}
+
+State *state_begin() {
+  if (state) {
+    unsigned int seq = atomic_load_explicit(&state->seq, memory_order_relaxed);
+    atomic_store_explicit(&state->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+  }
+  return state;
+}
+
+void state_end() {
+  if (state) {
+    unsigned int seq = atomic_load_explicit(&state->seq, memory_order_relaxed);
+    atomic_store_explicit(&state->seq, seq + 1, memory_order_release);
+  }
+}
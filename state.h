@@ -0,0 +1,20 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include "communication.h"
+
+/* Create the shared-memory state page, carrying on without one on failure */
+void state_init();
+
+/* Remove the shared-memory state page */
+void state_quit();
+
+/* Begin writing to the state page, returning NULL if there is none; readers
+ * retry until the write ends
+ */
+State *state_begin();
+
+/* Finish writing to the state page */
+void state_end();
+
+#endif /* !STATE_H */
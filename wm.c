@@ -1,9 +1,13 @@
 #include "wm.h"
 
 #include "server.h"
+#include "state.h"
 
 #include <X11/X.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xrandr.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,12 +19,15 @@ Display *dpy;
 
 Window root;
 
-Atom WM_PROTOCOLS, WM_DELETE_WINDOW;
+Atom WM_PROTOCOLS, WM_DELETE_WINDOW, NET_WM_PING;
 
 typedef struct {
   Window *windows; // ordered windows, stored TOS+n...TOS
   unsigned int num_windows;
+  unsigned int id; // stable for the lifetime of the stack
+  char *name;      // NULL when unnamed
 } WinStack;
+unsigned int next_stack_id = 0;
 #define window_at(stack, n) (stack).windows[(stack).num_windows - (n)-1]
 
 struct {
@@ -39,8 +46,52 @@ Splits split_stack = {
 };
 #define split_at(n) split_stack.splits[n]
 
+Bool auto_split = True; // whether splits follow the RandR monitors
+Bool has_randr = False;
+int randr_event_base, randr_error_base;
+
 unsigned int gap = 0;
 
+Bool state_dirty = True; // whether the state page is behind
+
+/* Liveness of each window, tracked through _NET_WM_PING */
+typedef struct {
+  Window win;
+  Bool pingable;     // whether the window supports _NET_WM_PING
+  long long sent;    // when the outstanding ping was sent, -1 if none
+  long long latency; // of the last answered ping, -1 if none were answered
+  long long kill_at; // when to kill the client after a pop, -1 if not popped
+} WinPing;
+WinPing *win_pings = NULL;
+unsigned int num_win_pings = 0;
+
+/* Windows recently mapped without being reported to `sosc wait map`, oldest
+ * first
+ */
+typedef struct {
+  Window win;
+  long long mapped; // when the window was mapped
+} Unreported;
+Unreported *unreported = NULL;
+unsigned int num_unreported = 0;
+
+unsigned int map_grace = 2000; // ms a map may precede `sosc wait map class=`
+
+unsigned int ping_interval = 5000; // ms between pings
+unsigned int ping_timeout = 1000;  // ms before a window is unresponsive
+unsigned int kill_timeout = 0;     // ms before killing a popped window
+long long next_ping = 0;
+
+/* Create an empty stack with a fresh id */
+WinStack new_stack() {
+  return (WinStack){
+      .windows = NULL,
+      .num_windows = 0,
+      .id = next_stack_id++,
+      .name = NULL,
+  };
+}
+
 /* Draw stack on given split */
 void draw_stack(WinStack stack, Split split) {
   for (unsigned int w = 0; w < stack.num_windows; w++) {
@@ -56,6 +107,7 @@ void draw_stack(WinStack stack, Split split) {
                         split.width - gap * 2, height - gap * 2);
     }
   }
+  state_dirty = True;
   // make sure TOS window remains the focus
   WinStack tos = win_stack_at(0);
   if (tos.num_windows) {
@@ -72,6 +124,7 @@ void hide_stack(WinStack stack) {
   for (unsigned int w = 0; w < stack.num_windows; w++) {
     XUnmapWindow(dpy, stack.windows[w]);
   }
+  state_dirty = True;
 }
 
 /* Redraw all windows */
@@ -85,6 +138,114 @@ void draw_all() {
   for (; s < stack_stack.num_win_stacks; s++) {
     hide_stack(win_stack_at(s));
   }
+  // republish even when there are no stacks left to draw or hide
+  state_dirty = True;
+}
+
+/* Publish a snapshot of the current state to the state page */
+void publish_state() {
+  State *state;
+  if (!(state = state_begin())) {
+    state_dirty = False;
+    return;
+  }
+  state->gap = gap;
+  state->focused = stack_stack.num_win_stacks && win_stack_at(0).num_windows
+                       ? window_at(win_stack_at(0), 0)
+                       : 0;
+  state->num_stacks = stack_stack.num_win_stacks;
+  for (unsigned int s = 0;
+       s < stack_stack.num_win_stacks && s < STATE_MAX_STACKS; s++) {
+    WinStack win_stack = win_stack_at(s);
+    state->stacks[s].id = win_stack.id;
+    state->stacks[s].num_windows = win_stack.num_windows;
+    state->stacks[s].tos =
+        win_stack.num_windows ? window_at(win_stack, 0) : 0;
+    state->stacks[s].name[0] = '\0';
+    if (win_stack.name) {
+      strncat(state->stacks[s].name, win_stack.name, STATE_NAME_SIZE - 1);
+    }
+  }
+  state->num_splits = split_stack.num_splits;
+  for (unsigned int s = 0; s < split_stack.num_splits && s < STATE_MAX_SPLITS;
+       s++) {
+    state->splits[s].width = split_at(s).width;
+    state->splits[s].height = split_at(s).height;
+    state->splits[s].x = split_at(s).x;
+    state->splits[s].y = split_at(s).y;
+  }
+  state_end();
+  state_dirty = False;
+}
+
+/* Order monitors with the primary first, then left to right, top to bottom */
+int compare_monitors(const void *a, const void *b) {
+  const XRRMonitorInfo *m = a, *n = b;
+  if (m->primary != n->primary) {
+    return n->primary - m->primary;
+  }
+  return m->x != n->x ? m->x - n->x : m->y - n->y;
+}
+
+/* Return a split for each active monitor, or for the whole screen if RandR
+ * isn't available
+ */
+Splits monitor_splits() {
+  Splits splits = {
+      .splits = NULL,
+      .num_splits = 0,
+  };
+  if (has_randr) {
+    int n;
+    XRRMonitorInfo *monitors = XRRGetMonitors(dpy, root, True, &n);
+    if (monitors && n > 0) {
+      qsort(monitors, n, sizeof(XRRMonitorInfo), compare_monitors);
+      splits.splits = malloc(n * sizeof(Split));
+      for (int m = 0; m < n; m++) {
+        splits.splits[m] = (Split){
+            .width = monitors[m].width,
+            .height = monitors[m].height,
+            .x = monitors[m].x,
+            .y = monitors[m].y,
+        };
+      }
+      splits.num_splits = n;
+    }
+    if (monitors) {
+      XRRFreeMonitors(monitors);
+    }
+  }
+  if (!splits.num_splits) {
+    Screen *scr = XDefaultScreenOfDisplay(dpy);
+    splits.splits = malloc(sizeof(Split));
+    splits.splits[0] = (Split){
+        .width = XWidthOfScreen(scr),
+        .height = XHeightOfScreen(scr),
+        .x = 0,
+        .y = 0,
+    };
+    splits.num_splits = 1;
+  }
+  return splits;
+}
+
+/* Replace the split stack, only redrawing stacks whose split changed */
+void update_splits(Splits updated_split_stack) {
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
+    Bool was_visible = s < split_stack.num_splits;
+    Bool is_visible = s < updated_split_stack.num_splits;
+    if (is_visible) {
+      Split split = updated_split_stack.splits[s];
+      if (!was_visible || memcmp(&split, &split_at(s), sizeof(Split))) {
+        draw_stack(win_stack_at(s), split);
+      }
+    } else if (was_visible) {
+      hide_stack(win_stack_at(s));
+    }
+  }
+  free(split_stack.splits);
+  split_stack = updated_split_stack;
+  state_dirty = True;
 }
 
 /* Return if a window exists, returning the location (NULL for split if it
@@ -103,7 +264,138 @@ Bool find_window(Window win, WinStack **win_stack, Split **split) {
   return False;
 }
 
+/* Return if a stack is referred to by name or id, returning its position
+ * relative to TOS; names take precedence over ids
+ */
+Bool find_stack(const char *ref, unsigned int *n) {
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
+    if (win_stack_at(s).name && !strcmp(win_stack_at(s).name, ref)) {
+      *n = s;
+      return True;
+    }
+  }
+  char *end;
+  unsigned long id = strtoul(ref, &end, 0);
+  if (*ref == '-' || end == ref || *end) {
+    return False;
+  }
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
+    if (win_stack_at(s).id == id) {
+      *n = s;
+      return True;
+    }
+  }
+  return False;
+}
+
+/* Return the liveness of a window, NULL if it isn't tracked */
+WinPing *find_win_ping(Window win) {
+  for (unsigned int p = 0; p < num_win_pings; p++) {
+    if (win_pings[p].win == win) {
+      return &win_pings[p];
+    }
+  }
+  return NULL;
+}
+
+/* Return if a window supports a WM_PROTOCOLS protocol */
+Bool supports_protocol(Window win, Atom proto) {
+  int n;
+  Atom *protos;
+  Bool supported = False;
+  if (XGetWMProtocols(dpy, win, &protos, &n)) {
+    while (n--) {
+      supported |= protos[n] == proto;
+    }
+    XFree(protos);
+  }
+  return supported;
+}
+
+/* Send a WM_PROTOCOLS message to a window */
+void send_protocol(Window win, Atom proto) {
+  const int LONG_SIZE = 32;
+  XEvent e;
+  e.xclient = (XClientMessageEvent){
+      .type = ClientMessage,
+      .window = win,
+      .message_type = WM_PROTOCOLS,
+      .format = LONG_SIZE,
+      .data = {.l = {proto, CurrentTime, win}}};
+  XSendEvent(dpy, win, False, NoEventMask, &e);
+}
+
+/* Ping a window, unless a ping is already outstanding */
+void ping_window(WinPing *win_ping, long long now) {
+  if (win_ping->pingable && win_ping->sent == -1) {
+    send_protocol(win_ping->win, NET_WM_PING);
+    win_ping->sent = now;
+  }
+}
+
+/* Ping windows and kill hung clients that are due, never waiting on replies */
+void ping_handler() {
+  long long now = now_ms();
+  if (now >= next_ping) {
+    for (unsigned int p = 0; p < num_win_pings; p++) {
+      ping_window(&win_pings[p], now);
+    }
+    next_ping = now + ping_interval;
+  }
+  for (unsigned int p = 0; p < num_win_pings; p++) {
+    WinPing *win_ping = &win_pings[p];
+    // windows without _NET_WM_PING can't show they are alive, so are killed
+    if (win_ping->kill_at != -1 && now >= win_ping->kill_at) {
+      XKillClient(dpy, win_ping->win);
+      win_ping->kill_at = -1;
+    }
+  }
+}
+
+/* Return the milliseconds until ping_handler() has work to do, or -1 */
+int ping_handler_timeout() {
+  long long now = now_ms(), next = -1;
+  for (unsigned int p = 0; p < num_win_pings; p++) {
+    if (win_pings[p].pingable && (next == -1 || next_ping < next)) {
+      next = next_ping;
+    }
+    if (win_pings[p].kill_at != -1 &&
+        (next == -1 || win_pings[p].kill_at < next)) {
+      next = win_pings[p].kill_at;
+    }
+  }
+  if (next == -1) {
+    return -1;
+  }
+  return next <= now ? 0 : next - now > INT_MAX ? INT_MAX : next - now;
+}
+
+/* Stop tracking a window as unreported */
+void remove_unreported(unsigned int n) {
+  num_unreported--;
+  memmove(unreported + n, unreported + n + 1,
+          (num_unreported - n) * sizeof(Unreported));
+}
+
+/* Forget unreported windows mapped too long ago to be claimed */
+void expire_unreported(long long now) {
+  while (num_unreported && now - unreported[0].mapped > map_grace) {
+    remove_unreported(0);
+  }
+}
+
 void remove_window(Window win) {
+  for (unsigned int u = 0; u < num_unreported; u++) {
+    if (unreported[u].win == win) {
+      remove_unreported(u);
+      break;
+    }
+  }
+  WinPing *win_ping;
+  if ((win_ping = find_win_ping(win))) {
+    num_win_pings--;
+    *win_ping = win_pings[num_win_pings];
+  }
   for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
     WinStack *win_stack = &win_stack_at(s);
     for (unsigned int w = 0; w < win_stack->num_windows; w++) {
@@ -133,6 +425,7 @@ int x_error(Display *dpy, XErrorEvent *err) {
 
 /* Continuously handle X events */
 void x_handler() {
+  Bool monitors_changed = False;
   while (XPending(dpy)) {
     // check for new X events
     XEvent e;
@@ -166,10 +459,7 @@ void x_handler() {
         if (!stack_stack.num_win_stacks) {
           stack_stack.num_win_stacks = 1;
           stack_stack.win_stacks = malloc(sizeof(WinStack));
-          stack_stack.win_stacks[0] = (WinStack){
-              .windows = NULL,
-              .num_windows = 0,
-          };
+          stack_stack.win_stacks[0] = new_stack();
         }
         win_stack = &win_stack_at(0);
         win_stack->num_windows++;
@@ -177,6 +467,36 @@ void x_handler() {
                                      win_stack->num_windows * sizeof(Window));
         window_at(*win_stack, 0) = win;
         draw_stack(*win_stack, split_at(0));
+        win_pings =
+            realloc(win_pings, (num_win_pings + 1) * sizeof(WinPing));
+        win_pings[num_win_pings++] = (WinPing){
+            .win = win,
+            .pingable = supports_protocol(win, NET_WM_PING),
+            .sent = -1,
+            .latency = -1,
+            .kill_at = -1,
+        };
+        // release `sosc wait map`, with the state page already showing it,
+        // otherwise keep the window for a later `sosc wait map class=...`
+        unsigned int released = 0;
+        if (server_waiting(WAIT_MAP)) {
+          publish_state();
+          XClassHint hint = {.res_name = NULL, .res_class = NULL};
+          XGetClassHint(dpy, win, &hint);
+          released = server_notify_map(win, hint.res_name, hint.res_class);
+          XFree(hint.res_name);
+          XFree(hint.res_class);
+        }
+        if (!released) {
+          long long now = now_ms();
+          expire_unreported(now);
+          unreported =
+              realloc(unreported, (num_unreported + 1) * sizeof(Unreported));
+          unreported[num_unreported++] = (Unreported){
+              .win = win,
+              .mapped = now,
+          };
+        }
       }
       break;
     }
@@ -194,8 +514,32 @@ void x_handler() {
       remove_window(e.xdestroywindow.window);
       break;
     }
+    case ClientMessage: {
+      // a _NET_WM_PING reply shows the client is alive, so stop any kill
+      XClientMessageEvent msg = e.xclient;
+      WinPing *win_ping;
+      if (msg.message_type == WM_PROTOCOLS &&
+          (Atom)msg.data.l[0] == NET_WM_PING &&
+          (win_ping = find_win_ping(msg.data.l[2])) && win_ping->sent != -1) {
+        win_ping->latency = now_ms() - win_ping->sent;
+        win_ping->sent = -1;
+        win_ping->kill_at = -1;
+      }
+      break;
+    }
+    default: {
+      if (has_randr && e.type == randr_event_base + RRScreenChangeNotify) {
+        XRRUpdateConfiguration(&e);
+        monitors_changed = True;
+      }
+      break;
+    }
     }
   }
+  // a hotplug sends a burst of notifications, so only resplit once
+  if (monitors_changed && auto_split) {
+    update_splits(monitor_splits());
+  }
 }
 
 int main() {
@@ -208,25 +552,26 @@ int main() {
   XSetErrorHandler(x_error);
   XSelectInput(dpy, root, SubstructureNotifyMask | SubstructureRedirectMask);
 
-  // set default split
-  Screen *scr = XDefaultScreenOfDisplay(dpy);
-  split_stack = (Splits){
-      .splits = malloc(sizeof(Split)),
-      .num_splits = 1,
-  };
-  split_at(0) = (Split){
-      .width = XWidthOfScreen(scr),
-      .height = XHeightOfScreen(scr),
-      .x = 0,
-      .y = 0,
-  };
+  // split by monitor, following any changes to them; monitors need RandR 1.5
+  int randr_major, randr_minor;
+  const int MONITORS_MAJOR = 1, MONITORS_MINOR = 5;
+  if (XRRQueryExtension(dpy, &randr_event_base, &randr_error_base) &&
+      XRRQueryVersion(dpy, &randr_major, &randr_minor) &&
+      (randr_major > MONITORS_MAJOR ||
+       (randr_major == MONITORS_MAJOR && randr_minor >= MONITORS_MINOR))) {
+    has_randr = True;
+    XRRSelectInput(dpy, root, RRScreenChangeNotifyMask);
+  }
+  split_stack = monitor_splits();
 
   // initialize communication protocols
   WM_PROTOCOLS = XInternAtom(dpy, "WM_PROTOCOLS", False);
   WM_DELETE_WINDOW = XInternAtom(dpy, "WM_DELETE_WINDOW", False);
+  NET_WM_PING = XInternAtom(dpy, "_NET_WM_PING", False);
 
   // initialize and run server
   server_init();
+  state_init();
 
   // run startup program
   if (!fork()) {
@@ -246,12 +591,42 @@ int main() {
     FD_SET(x_fd, &set);
     FD_SET(connection_socket, &set);
     int max_fd = x_fd > connection_socket ? x_fd : connection_socket;
-    // wait for any change, always checking X after
-    select(max_fd + 1, &set, NULL, NULL, NULL);
+    int waiter_fd = server_fds(&set);
+    max_fd = waiter_fd > max_fd ? waiter_fd : max_fd;
+    // wait for any change, for a waiting client to time out or hang up or for
+    // a ping to be due, always checking X after
+    int timeout = server_timeout(), ping_due = ping_handler_timeout();
+    if (timeout == -1 || (ping_due != -1 && ping_due < timeout)) {
+      timeout = ping_due;
+    }
+    const int MS_PER_S = 1000, US_PER_MS = 1000;
+    struct timeval tv = {
+        .tv_sec = timeout / MS_PER_S,
+        .tv_usec = timeout % MS_PER_S * US_PER_MS,
+    };
+    if (select(max_fd + 1, &set, NULL, NULL, timeout == -1 ? NULL : &tv) ==
+        -1) {
+      FD_ZERO(&set);
+    }
+    server_reap(&set);
+    server_expire();
+    ping_handler();
     if (FD_ISSET(connection_socket, &set)) {
       server_handler();
     }
+    // make sure the X server has caught up before deciding soswm is idle
+    if (server_waiting(WAIT_IDLE)) {
+      XSync(dpy, False);
+    }
     x_handler();
+    // publish once all changes from this wake-up have been laid out
+    if (state_dirty) {
+      publish_state();
+      server_notify(WAIT_RELAYOUT);
+    }
+    if (!QLength(dpy)) {
+      server_notify(WAIT_IDLE);
+    }
   }
 
   return 0;
@@ -262,10 +637,7 @@ void push_stack() {
   stack_stack.num_win_stacks++;
   stack_stack.win_stacks = realloc(
       stack_stack.win_stacks, stack_stack.num_win_stacks * sizeof(WinStack));
-  win_stack_at(0) = (WinStack){
-      .windows = NULL,
-      .num_windows = 0,
-  };
+  win_stack_at(0) = new_stack();
   draw_all();
 }
 
@@ -274,26 +646,17 @@ void pop_window() {
     WinStack tos = win_stack_at(0);
     if (tos.num_windows) {
       Window win = window_at(tos, 0);
-      int n;
-      Atom *protos;
       // first, try to tell the window to close
-      if (XGetWMProtocols(dpy, win, &protos, &n)) {
-        while (n--) {
-          if (protos[n] == WM_DELETE_WINDOW) {
-            const int LONG_SIZE = 32;
-            XEvent e;
-            e.xclient = (XClientMessageEvent){
-              .type = ClientMessage,
-              .window = win,
-              .message_type = WM_PROTOCOLS,
-              .format = LONG_SIZE,
-              .data = {.l[0] = WM_DELETE_WINDOW}};
-            XSendEvent(dpy, win, False, NoEventMask, &e);
-            XFree(protos);
-            return;
-          }
+      if (supports_protocol(win, WM_DELETE_WINDOW)) {
+        send_protocol(win, WM_DELETE_WINDOW);
+        // if enabled, kill the client unless it answers a ping in time
+        WinPing *win_ping;
+        if (kill_timeout && (win_ping = find_win_ping(win))) {
+          long long now = now_ms();
+          ping_window(win_ping, now);
+          win_ping->kill_at = now + kill_timeout;
         }
-        XFree(protos);
+        return;
       }
       // if the client has no deletion protocol, forcefully kill it
       XKillClient(dpy, win);
@@ -304,6 +667,7 @@ void pop_window() {
 void pop_stack() {
   if (stack_stack.num_win_stacks && !win_stack_at(0).num_windows) {
     free(win_stack_at(0).windows);
+    free(win_stack_at(0).name);
     stack_stack.num_win_stacks--;
     draw_all();
   }
@@ -386,19 +750,132 @@ void swap_stack(unsigned int n) {
   }
 }
 
+void name_stack(char *name) {
+  if (stack_stack.num_win_stacks) {
+    // names are unique, so take it from any stack that already has it
+    for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
+      WinStack *win_stack = &win_stack_at(s);
+      if (win_stack->name && !strcmp(win_stack->name, name)) {
+        free(win_stack->name);
+        win_stack->name = NULL;
+      }
+    }
+    WinStack *tos = &win_stack_at(0);
+    free(tos->name);
+    tos->name = malloc(strlen(name) + 1);
+    strcpy(tos->name, name);
+    state_dirty = True;
+  }
+}
+
+void focus_stack(char *ref, char *buf, unsigned int size) {
+  unsigned int n;
+  if (find_stack(ref, &n)) {
+    swap_stack(n);
+  } else {
+    snprintf(buf, size, "Invalid argument: `%s`\nExpected stack name or id\n",
+             ref);
+  }
+}
+
+void focus_window(unsigned long win, char *buf, unsigned int size) {
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks; s++) {
+    WinStack *win_stack = &win_stack_at(s);
+    for (unsigned int w = 0; w < win_stack->num_windows; w++) {
+      if (window_at(*win_stack, w) == win) {
+        // bring the window to the TOS of its stack, then the stack to TOS
+        window_at(*win_stack, w) = window_at(*win_stack, 0);
+        window_at(*win_stack, 0) = win;
+        WinStack tos = win_stack_at(0);
+        win_stack_at(0) = *win_stack;
+        *win_stack = tos;
+        draw_all();
+        return;
+      }
+    }
+  }
+  snprintf(buf, size, "Invalid argument: `0x%lx`\nExpected managed window\n",
+           win);
+}
+
+void query_stacks(char *buf, unsigned int size) {
+  unsigned int len = 0;
+  buf[0] = '\0';
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks && len < size; s++) {
+    WinStack win_stack = win_stack_at(s);
+    len += snprintf(buf + len, size - len, "%u %s", win_stack.id,
+                    win_stack.name ? win_stack.name : "-");
+    for (unsigned int w = 0; w < win_stack.num_windows && len < size; w++) {
+      len += snprintf(buf + len, size - len, " 0x%lx", window_at(win_stack, w));
+    }
+    if (len < size) {
+      len += snprintf(buf + len, size - len, "\n");
+    }
+  }
+}
+
+void query_windows(char *buf, unsigned int size) {
+  unsigned int len = 0;
+  long long now = now_ms();
+  buf[0] = '\0';
+  for (unsigned int s = 0; s < stack_stack.num_win_stacks && len < size; s++) {
+    WinStack win_stack = win_stack_at(s);
+    for (unsigned int w = 0; w < win_stack.num_windows && len < size; w++) {
+      Window win = window_at(win_stack, w);
+      WinPing *win_ping = find_win_ping(win);
+      const char *status = "unknown";
+      if (win_ping && win_ping->pingable) {
+        status = win_ping->sent != -1 && now - win_ping->sent > ping_timeout
+                     ? "unresponsive"
+                     : "responsive";
+      }
+      len += snprintf(buf + len, size - len, "0x%lx %u %s", win, win_stack.id,
+                      status);
+      if (len < size) {
+        len += win_ping && win_ping->latency != -1
+                   ? snprintf(buf + len, size - len, " %lldms\n",
+                              win_ping->latency)
+                   : snprintf(buf + len, size - len, " -\n");
+      }
+    }
+  }
+}
+
 void set_gap(unsigned int n) {
   gap = n;
   draw_all();
 }
 
+void set_kill_timeout(unsigned int n) {
+  kill_timeout = n > MAX_TIMEOUT ? MAX_TIMEOUT : n;
+}
+
 void split_screen(Splits updated_split_stack) {
-  free(split_stack.splits);
-  split_stack = updated_split_stack;
-  draw_all();
+  auto_split = !updated_split_stack.num_splits;
+  update_splits(auto_split ? monitor_splits() : updated_split_stack);
+}
+
+int claim_mapped_window(const char *class, unsigned long *win) {
+  // only a window mapped just before the wait can be the one it is after
+  expire_unreported(now_ms());
+  for (unsigned int u = 0; u < num_unreported; u++) {
+    XClassHint hint = {.res_name = NULL, .res_class = NULL};
+    XGetClassHint(dpy, unreported[u].win, &hint);
+    Bool matches = class_matches(class, hint.res_name, hint.res_class);
+    XFree(hint.res_name);
+    XFree(hint.res_class);
+    if (matches) {
+      *win = unreported[u].win;
+      remove_unreported(u);
+      return True;
+    }
+  }
+  return False;
 }
 
 void logout_wm() {
   XCloseDisplay(dpy);
   server_quit();
+  state_quit();
   exit(0);
 }
@@ -20,10 +20,25 @@ void roll_stack(RollDirection);
 /* sosc move window <0...inf> */
 void move_window(unsigned int);
 
-/* sosc set gap <0...inf> */
+/* sosc name stack <name> */
+void name_stack(char *);
+
+/* sosc focus stack <name | id>, sosc focus window <xid> */
+void focus_stack(char *, char *, unsigned int);
+void focus_window(unsigned long, char *, unsigned int);
+
+/* sosc query <stacks | windows> */
+void query_stacks(char *, unsigned int);
+void query_windows(char *, unsigned int);
+
+/* sosc set <gap | kill-timeout> <0...inf> */
 void set_gap(unsigned int);
+void set_kill_timeout(unsigned int);
 
-/* sosc split screen <WxH+X+Y> ... */
+/* sosc split screen <auto | WxH+X+Y ...>
+ *
+ * No splits means split automatically by RandR monitor.
+ */
 typedef struct {
   unsigned int width, height;
   int x, y;
@@ -34,6 +49,14 @@ typedef struct {
 } Splits;
 void split_screen(Splits);
 
+/* sosc wait map class=<class>
+ *
+ * Return if a window matching the class was mapped within the last two seconds
+ * without being reported to a waiting client, reporting the oldest such
+ * window.
+ */
+int claim_mapped_window(const char *, unsigned long *);
+
 /* sosc logout */
 void logout_wm();
 